@@ -0,0 +1,44 @@
+#ifndef PACKET_SIZE_HH
+#define PACKET_SIZE_HH
+
+#include <utility>
+
+// Constants
+#define MIN_PACKET_SIZE 64 // Smallest packet used for pps stress tests
+#define MAX_PACKET_SIZE 9000 // Jumbo frame
+#define DEFAULT_PACKET_SIZE 1500
+
+// Packet length known at compile time. The common sizes get their own
+// instantiation of the attack loops with the length as a constant; the
+// per-packet cost is still dominated by the sendto system call, so this
+// is not a measurable speedup. PacketLength<0> is the generic path and
+// uses the size given at runtime.
+template <int Size>
+struct PacketLength {
+    static inline int get(int) { return Size; }
+};
+
+template <>
+struct PacketLength<0> {
+    static inline int get(int runtime_size) { return runtime_size; }
+};
+
+inline bool valid_packet_size(int packet_size) {
+    return packet_size >= MIN_PACKET_SIZE && packet_size <= MAX_PACKET_SIZE;
+}
+
+// Calls Fn<Size>::run(args...) with the specialized Size matching
+// packet_size, falling back to Fn<0>::run(args...) for other sizes.
+template <template <int> class Fn, typename... Args>
+void dispatch_packet_size(int packet_size, Args&&... args) {
+    switch (packet_size) {
+    case 64:   Fn<64>::run(std::forward<Args>(args)...); break;
+    case 128:  Fn<128>::run(std::forward<Args>(args)...); break;
+    case 256:  Fn<256>::run(std::forward<Args>(args)...); break;
+    case 1500: Fn<1500>::run(std::forward<Args>(args)...); break;
+    case 9000: Fn<9000>::run(std::forward<Args>(args)...); break;
+    default:   Fn<0>::run(std::forward<Args>(args)...); break;
+    }
+}
+
+#endif // PACKET_SIZE_HH
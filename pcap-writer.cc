@@ -0,0 +1,209 @@
+#include <cstring>
+#include <iostream>
+
+#include <arpa/inet.h>
+
+#include "pcap-writer.hh"
+
+#define IP_UDP_HEADER_SIZE 28
+#define LINKTYPE_IPV4 228 // Raw IPv4, no link layer header
+#define EPB_OVERHEAD 32 // Enhanced Packet Block without its packet data
+
+static void put_u32(char* p, uint32_t value) {
+    memcpy(p, &value, sizeof(value));
+}
+
+PcapWriter::PcapWriter() : snaplen(DEFAULT_PCAP_SNAPLEN), stopping(false), dropped_records(0), lost_records(0) {
+    current.data = NULL;
+    current.len = 0;
+    current.records = 0;
+}
+
+PcapWriter::~PcapWriter() {
+    close();
+}
+
+// Section Header Block and Interface Description Block. Records use
+// nanosecond timestamps (if_tsresol = 9). pcapng is written in host byte
+// order; readers detect it from the byte-order magic.
+void PcapWriter::write_headers() {
+    char shb[28];
+    put_u32(shb, 0x0A0D0D0A);
+    put_u32(shb + 4, sizeof(shb));
+    put_u32(shb + 8, 0x1A2B3C4D);
+    uint16_t version[2] = { 1, 0 };
+    memcpy(shb + 12, version, sizeof(version));
+    int64_t section_length = -1; // Not known in advance
+    memcpy(shb + 16, &section_length, sizeof(section_length));
+    put_u32(shb + 24, sizeof(shb));
+    file.write(shb, sizeof(shb));
+
+    char idb[32];
+    memset(idb, 0, sizeof(idb));
+    put_u32(idb, 1);
+    put_u32(idb + 4, sizeof(idb));
+    uint16_t linktype = LINKTYPE_IPV4;
+    memcpy(idb + 8, &linktype, sizeof(linktype));
+    put_u32(idb + 12, snaplen);
+    uint16_t tsresol[2] = { 9, 1 }; // Option code, length
+    memcpy(idb + 16, tsresol, sizeof(tsresol));
+    idb[20] = 9; // 10^-9 s; idb[24..27] is opt_endofopt
+    put_u32(idb + 28, sizeof(idb));
+    file.write(idb, sizeof(idb));
+}
+
+bool PcapWriter::open(const std::string& filename, int capture_snaplen) {
+    if (capture_snaplen < IP_UDP_HEADER_SIZE || capture_snaplen > 65535) {
+        std::cerr << "Error: Capture snaplen must be between " << IP_UDP_HEADER_SIZE << " and 65535 bytes." << std::endl;
+        return false;
+    }
+    snaplen = capture_snaplen;
+
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Unable to open capture file " << filename << std::endl;
+        return false;
+    }
+    write_headers();
+    if (!file.flush()) {
+        std::cerr << "Error: Unable to write capture file " << filename << std::endl;
+        file.close();
+        return false;
+    }
+
+    // Touch every block now so the hot path never faults them in
+    for (int i = 0; i < PCAP_BLOCKS; i++) {
+        char* block = new char[PCAP_BLOCK_SIZE];
+        memset(block, 0, PCAP_BLOCK_SIZE);
+        blocks.push_back(block);
+        free_blocks.push_back(block);
+    }
+    current.data = free_blocks.back();
+    current.len = 0;
+    current.records = 0;
+    free_blocks.pop_back();
+
+    stopping = false;
+    writer_thread = std::thread(&PcapWriter::writer_loop, this);
+    return true;
+}
+
+// Queues the current block for writing and takes a free one, if any
+void PcapWriter::hand_off_current() {
+    std::lock_guard<std::mutex> lock(block_mutex);
+    if (current.data != NULL) {
+        full_blocks.push_back(current);
+        block_ready.notify_one();
+    }
+    if (free_blocks.empty()) {
+        current.data = NULL;
+    } else {
+        current.data = free_blocks.back();
+        free_blocks.pop_back();
+    }
+    current.len = 0;
+    current.records = 0;
+}
+
+void PcapWriter::writer_loop() {
+    std::unique_lock<std::mutex> lock(block_mutex);
+    while (true) {
+        block_ready.wait(lock, [this] { return stopping || !full_blocks.empty(); });
+        if (full_blocks.empty()) {
+            break; // Stopping and everything is written
+        }
+        Block block = full_blocks.front();
+        full_blocks.pop_front();
+
+        // Flushed per block so a failure is charged to the records it lost
+        lock.unlock();
+        if (!file.write(block.data, block.len).flush()) {
+            lost_records += block.records;
+        }
+        lock.lock();
+
+        free_blocks.push_back(block.data);
+    }
+}
+
+bool PcapWriter::close() {
+    if (!file.is_open()) {
+        return true;
+    }
+
+    hand_off_current();
+    {   std::lock_guard<std::mutex> lock(block_mutex);
+        stopping = true;
+    }
+    block_ready.notify_one();
+    writer_thread.join();
+    file.close();
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        delete[] blocks[i];
+    }
+    blocks.clear();
+    free_blocks.clear();
+    current.data = NULL;
+
+    if (lost_records > 0) {
+        std::cerr << "Error: Failed to write " << lost_records << " records to the capture file; the capture is incomplete." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void PcapWriter::record(const struct timespec& ts, const UDPSocket::SockAddress& src, const UDPSocket::SockAddress& dst, const char* payload, int payload_len) {
+    uint32_t orig_len = IP_UDP_HEADER_SIZE + payload_len;
+    uint32_t cap_len = orig_len < static_cast<uint32_t>(snaplen) ? orig_len : snaplen;
+    uint32_t padded_len = (cap_len + 3) & ~3u;
+    uint32_t block_len = EPB_OVERHEAD + padded_len;
+
+    if (current.data == NULL || current.len + block_len > PCAP_BLOCK_SIZE) {
+        hand_off_current();
+        if (current.data == NULL) {
+            dropped_records++; // Writer thread has not caught up
+            return;
+        }
+    }
+
+    char* p = current.data + current.len;
+    uint64_t ts_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    put_u32(p, 6); // Enhanced Packet Block
+    put_u32(p + 4, block_len);
+    put_u32(p + 8, 0); // Interface ID
+    put_u32(p + 12, ts_ns >> 32);
+    put_u32(p + 16, ts_ns & 0xFFFFFFFF);
+    put_u32(p + 20, cap_len);
+    put_u32(p + 24, orig_len);
+
+    // IPv4 header, in network byte order
+    uint16_t ip[10];
+    ip[0] = htons(0x4500); // Version 4, IHL 5
+    ip[1] = htons(orig_len > 65535 ? 65535 : orig_len);
+    ip[2] = 0;
+    ip[3] = htons(0x4000); // Don't fragment
+    ip[4] = htons((64 << 8) | IPPROTO_UDP); // TTL 64
+    ip[5] = 0;
+    memcpy(&ip[6], &src.sin_addr, 4);
+    memcpy(&ip[8], &dst.sin_addr, 4);
+    uint32_t sum = 0;
+    for (int i = 0; i < 10; i++) {
+        sum += ip[i];
+    }
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    ip[5] = ~sum;
+    memcpy(p + 28, ip, sizeof(ip));
+
+    // UDP header, checksum left out (0)
+    uint16_t udp[4] = { src.sin_port, dst.sin_port, htons(8 + payload_len), 0 };
+    memcpy(p + 48, udp, sizeof(udp));
+
+    memcpy(p + 56, payload, cap_len - IP_UDP_HEADER_SIZE);
+    memset(p + 28 + cap_len, 0, padded_len - cap_len);
+    put_u32(p + block_len - 4, block_len);
+
+    current.len += block_len;
+    current.records++;
+}
@@ -0,0 +1,70 @@
+#ifndef PCAP_WRITER_HH
+#define PCAP_WRITER_HH
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+#include "udp-socket.hh"
+
+#define DEFAULT_PCAP_SNAPLEN 64 // IPv4 + UDP headers and the first 36 payload bytes
+#define PCAP_BLOCK_SIZE (4 * 1024 * 1024) // Bytes handed to the writer thread at a time
+#define PCAP_BLOCKS 8 // Preallocated blocks; records are dropped if all are waiting for disk
+
+// Streams a pcapng capture of the packets a program sends or receives.
+// Each record is an IPv4/UDP header rebuilt from the socket addresses plus
+// the start of the payload, truncated to snaplen, with a nanosecond
+// timestamp. record() only copies into a preallocated block; full blocks
+// are written out by a background thread. Single producer: record() must
+// always be called from the same thread.
+class PcapWriter {
+private:
+    struct Block {
+        char* data;
+        size_t len;
+        uint64_t records;
+    };
+
+    std::ofstream file;
+    int snaplen;
+    std::vector<char*> blocks;
+    Block current; // Block being filled, data is NULL if none was free
+    std::vector<char*> free_blocks;
+    std::deque<Block> full_blocks;
+    std::mutex block_mutex;
+    std::condition_variable block_ready;
+    std::thread writer_thread;
+    bool stopping;
+    std::atomic<uint64_t> dropped_records;
+    std::atomic<uint64_t> lost_records; // Handed to the writer but not written, e.g. disk full
+
+    void write_headers();
+    void hand_off_current();
+    void writer_loop();
+
+public:
+    PcapWriter();
+    ~PcapWriter();
+
+    bool open(const std::string& filename, int snaplen);
+    // Writes out what is left and closes the file. Returns false if any
+    // record could not be written, so the capture is incomplete.
+    bool close();
+    bool is_open() const { return file.is_open(); }
+    uint64_t dropped() const { return dropped_records; }
+    uint64_t lost() const { return lost_records; }
+
+    // Appends a record for a UDP datagram of payload_len bytes from src to
+    // dst, captured at ts (CLOCK_REALTIME). Never blocks on disk I/O.
+    void record(const struct timespec& ts, const UDPSocket::SockAddress& src, const UDPSocket::SockAddress& dst, const char* payload, int payload_len);
+};
+
+#endif // PCAP_WRITER_HH
@@ -3,11 +3,26 @@
 #include <chrono>
 #include <cstring>
 #include <fstream>
+#include <csignal>
 #include "udp-socket.hh"
 #include "receiver.hh"
 
 std::ofstream log_file("receiver_log.txt"); // Log file for receiver activity "receiver_log.txt"
 
+RTProfile rt_profile; // Real-time execution profile, set with -r
+WakeupStats recv_wakeup_stats; // Kernel receive to receive loop lateness, with a real-time profile
+
+// Capture of received packets, open when -p is given
+PcapWriter pcap_writer;
+UDPSocket::SockAddress pcap_local_addr; // Destination address written in the capture
+
+// Set by SIGINT/SIGTERM so the receive loop can stop and flush its output
+volatile sig_atomic_t stop_receiver = 0;
+
+void handle_stop_signal(int) {
+    stop_receiver = 1;
+}
+
 // Initialize receiver by binding to a specific port
 bool initialize_receiver(UDPSocket& socket, int port) {
     if (socket.bindsocket(port) == 0) { // Using bindsocket instead of bind
@@ -34,7 +49,7 @@ void log_received_packet(const Packet& packet, int packet_size, long inter_arriv
 
 
 // Log interval throughput and reset for next interval
-void log_interval_throughput(int interval_bytes_received, double interval_duration_s) {
+void log_interval_throughput(uint64_t interval_bytes_received, double interval_duration_s) {
     double throughput_bps = (interval_bytes_received * 8) / interval_duration_s; // Throughput in bits per second
     auto now = std::chrono::steady_clock::now();
     auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
@@ -63,40 +78,22 @@ void send_ack(UDPSocket& socket, int ack_number, UDPSocket::SockAddress& sender_
 //               << " ms, seq_number: " << packet.seq_number << std::endl;
 // }
 
-int main(int argc, char *argv[]) {
-
-    if (!log_file.is_open()) {
-        std::cerr << "Error: Failed to open receiver_log.txt for logging." << std::endl;
-        return 1; // Ensure the program exits if the file cannot be opened
-    }
-
-    // Command-line arguments
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <Port>" << std::endl;
-        return 1;
-    }
-
-    int port = std::stoi(argv[1]);
-
-    // UDP socket setup
-    UDPSocket socket;
-    if (!initialize_receiver(socket, port)) {
-        return 1;
-    }
-
-    auto start_time = std::chrono::steady_clock::now(); // Start of the experiment
-    auto last_log_time = std::chrono::steady_clock::now();
-
-    char buffer[BUFFER_SIZE];
+// Receive loop. Every datagram is read whole, up to MAX_PACKET_SIZE, and
+// counted at its real length; packet_size is only the size the sender is
+// expected to use, and datagrams of any other size are counted separately.
+void receive_loop(UDPSocket& socket, int packet_size, uint64_t& total_bytes_received, uint64_t& unexpected_size_packets) {
+    char buffer[BUFFER_SIZE + 1]; // receivedata null terminates the buffer
+    struct timespec rx_time;
     //int seq_number = 0;
     UDPSocket::SockAddress other_addr;
 
     auto last_receive_time = std::chrono::steady_clock::now();
 
-    int total_bytes_received = 0;
-    int interval_bytes_received = 0;
+    auto last_log_time = std::chrono::steady_clock::now();
+    auto last_stats_time = last_log_time;
+    uint64_t interval_bytes_received = 0;
 
-    while (true) {
+    while (!stop_receiver) {
 
         // Check elapsed time to break loop
         // auto now = std::chrono::steady_clock::now();
@@ -109,18 +106,34 @@ int main(int argc, char *argv[]) {
         // Receive packets
         int received;
         try {
-            received = socket.receivedata(buffer, BUFFER_SIZE, -1, other_addr);
+            // 100ms timeout so a stop signal is noticed
+            received = socket.receivedata(buffer, BUFFER_SIZE, 100, other_addr, rt_profile.enabled ? &rx_time : NULL);
         } catch (const std::exception& e) {
             std::cerr << "Failed to receive packet: " << e.what() << std::endl;
             continue; // Continue listening even after a receive failure
         }
-        
+        if (received < static_cast<int>(HEADER_SIZE)) {
+            continue; // Error or runt datagram without a sequence number
+        }
+        if (rt_profile.enabled && rx_time.tv_sec != 0) {
+            recv_wakeup_stats.record(rx_wakeup_lateness_ns(rx_time));
+        }
+        if (pcap_writer.is_open()) {
+            // Prefer the kernel receive time when the real-time profile asked for it
+            if (!rt_profile.enabled || rx_time.tv_sec == 0) {
+                clock_gettime(CLOCK_REALTIME, &rx_time);
+            }
+            pcap_writer.record(rx_time, other_addr, pcap_local_addr, buffer, received);
+        }
+
+        if (received != packet_size) {
+            unexpected_size_packets++;
+        }
         total_bytes_received += received;
         interval_bytes_received += received;
 
         // Populate the Packet structure
         Packet packet;
-        strncpy(packet.data, buffer, received);
         //packet.seq_number = seq_number++;
         memcpy(&packet.seq_number, buffer, sizeof(packet.seq_number)); // Extract seq_number from received packet
         packet.receive_time = std::chrono::steady_clock::now();
@@ -145,15 +158,107 @@ int main(int argc, char *argv[]) {
             // // Debugging statement to confirm logging is occurring
             // std::cout << "Logged data to receiver_log.txt at time(ms): " << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() << std::endl;
         }
+
+        // The receiver runs until killed, so report wakeup lateness every second
+        if (rt_profile.enabled && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_stats_time).count() >= 1000) {
+            recv_wakeup_stats.report(log_file, "receive");
+            last_stats_time = now;
+        }
     }
+}
+
+int main(int argc, char *argv[]) {
+
+    if (!log_file.is_open()) {
+        std::cerr << "Error: Failed to open receiver_log.txt for logging." << std::endl;
+        return 1; // Ensure the program exits if the file cannot be opened
+    }
+
+    // Command-line arguments
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <Port> [packet_size] [-r <rt_profile>] [-p <pcap_file>] [-P <snaplen>]" << std::endl;
+        return 1;
+    }
+
+    int port = std::stoi(argv[1]);
+    int packet_size = DEFAULT_PACKET_SIZE;
+    std::string pcap_file;
+    int pcap_snaplen = DEFAULT_PCAP_SNAPLEN;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-r" && i + 1 < argc) {
+            if (!parse_rt_profile(argv[++i], RT_RECEIVER, rt_profile)) {
+                return 1;
+            }
+        } else if (arg == "-p" && i + 1 < argc) {
+            pcap_file = argv[++i];
+        } else if (arg == "-P" && i + 1 < argc) {
+            pcap_snaplen = std::stoi(argv[++i]);
+        } else if (i == 2) {
+            packet_size = std::stoi(arg);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " <Port> [packet_size] [-r <rt_profile>] [-p <pcap_file>] [-P <snaplen>]" << std::endl;
+            return 1;
+        }
+    }
+    if (!valid_packet_size(packet_size)) {
+        std::cerr << "Error: Packet size must be between " << MIN_PACKET_SIZE << " and " << MAX_PACKET_SIZE << " bytes." << std::endl;
+        return 1;
+    }
+
+    // UDP socket setup
+    UDPSocket socket;
+    if (!initialize_receiver(socket, port)) {
+        return 1;
+    }
+
+    if (!pcap_file.empty()) {
+        if (!pcap_writer.open(pcap_file, pcap_snaplen)) {
+            return 1;
+        }
+        // Bound to INADDR_ANY, so the capture shows 0.0.0.0 as the destination
+        memset(&pcap_local_addr, 0, sizeof(pcap_local_addr));
+        pcap_local_addr.sin_family = AF_INET;
+        pcap_local_addr.sin_port = htons(port);
+    }
+
+    signal(SIGINT, handle_stop_signal);
+    signal(SIGTERM, handle_stop_signal);
+
+    if (rt_profile.enabled) {
+        if (socket.set_buffer_sizes(rt_profile.sndbuf, rt_profile.rcvbuf) != 0 || socket.enable_rx_timestamps() != 0) {
+            return 1;
+        }
+        if (!apply_process_profile(rt_profile) || !apply_thread_profile(pthread_self(), rt_profile.recv_cpu, rt_profile.fifo_priority, "receive")) {
+            return 1;
+        }
+        log_file << "RT Profile: " << rt_profile.describe() << std::endl;
+    }
+
+    auto start_time = std::chrono::steady_clock::now(); // Start of the experiment
+
+    uint64_t total_bytes_received = 0;
+    uint64_t unexpected_size_packets = 0;
+
+    receive_loop(socket, packet_size, total_bytes_received, unexpected_size_packets);
 
     // End time after the loop completes
     auto end_time = std::chrono::steady_clock::now();
-    double duration_seconds = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time).count();
-    double average_throughput = (total_bytes_received * 8) / duration_seconds; // in bits per second
+    double duration_seconds = std::chrono::duration<double>(end_time - start_time).count();
+    double average_throughput = (static_cast<double>(total_bytes_received) * 8) / duration_seconds; // in bits per second
 
     log_file << "Average Throughput (bps): " << average_throughput << std::endl;
+    log_file << "Packets Not of Size " << packet_size << ": " << unexpected_size_packets << std::endl;
+    if (rt_profile.enabled) {
+        recv_wakeup_stats.report(log_file, "receive");
+    }
+    bool capture_complete = true;
+    if (pcap_writer.is_open()) {
+        capture_complete = pcap_writer.close();
+        log_file << "Capture: " << pcap_file << ", Dropped Records: " << pcap_writer.dropped()
+                 << ", Lost Records: " << pcap_writer.lost() << std::endl;
+    }
 
     log_file.close();
-    return 0;
+    return capture_complete ? 0 : 1;
 }
\ No newline at end of file
@@ -3,9 +3,13 @@
 
 #include <string>
 #include <chrono>
+#include "packet-size.hh"
+#include "pcap-writer.hh"
+#include "rt-profile.hh"
 
 // Constants
-#define BUFFER_SIZE 1500
+#define BUFFER_SIZE MAX_PACKET_SIZE
+#define HEADER_SIZE sizeof(int)  // Size of seq_number
 
 // // Packet structure for received data
 struct Packet {
@@ -0,0 +1,199 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <malloc.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "rt-profile.hh"
+
+std::string RTProfile::describe() const {
+    std::ostringstream out;
+    out << "send cpu " << send_cpu << ", ack cpu " << ack_cpu << ", recv cpu " << recv_cpu
+        << ", fifo priority " << fifo_priority
+        << ", mlock " << (lock_memory ? "on" : "off")
+        << ", prefault " << (prefault ? "on" : "off")
+        << ", sndbuf " << sndbuf << ", rcvbuf " << rcvbuf;
+    return out.str();
+}
+
+WakeupStats::WakeupStats() : count(0), min_ns(0), max_ns(0), sum_ns(0) {
+    memset(buckets, 0, sizeof(buckets));
+}
+
+void WakeupStats::record(int64_t lateness_ns) {
+    if (lateness_ns < 0) {
+        lateness_ns = 0; // Woke up early
+    }
+    if (count == 0 || lateness_ns < min_ns) {
+        min_ns = lateness_ns;
+    }
+    if (lateness_ns > max_ns) {
+        max_ns = lateness_ns;
+    }
+    count++;
+    sum_ns += lateness_ns;
+
+    int bucket = 0;
+    int64_t lateness_us = lateness_ns / 1000;
+    while (bucket < WAKEUP_BUCKETS - 1 && lateness_us >= (int64_t(1) << bucket)) {
+        bucket++;
+    }
+    buckets[bucket]++;
+}
+
+// Upper bound, in us, of the bucket holding the given fraction of samples
+int64_t WakeupStats::percentile_bound_us(double fraction) const {
+    uint64_t wanted = static_cast<uint64_t>(fraction * count);
+    uint64_t seen = 0;
+    for (int i = 0; i < WAKEUP_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > wanted) {
+            return int64_t(1) << i;
+        }
+    }
+    return int64_t(1) << (WAKEUP_BUCKETS - 1);
+}
+
+void WakeupStats::report(std::ostream& out, const std::string& name) const {
+    out << "[Wakeup] Thread: " << name << ", Samples: " << count;
+    if (count > 0) {
+        out << ", Min(us): " << min_ns / 1000.0
+            << ", Mean(us): " << sum_ns / count / 1000.0
+            << ", Max(us): " << max_ns / 1000.0
+            << ", P50(us) <= " << percentile_bound_us(0.5)
+            << ", P99(us) <= " << percentile_bound_us(0.99)
+            << ", P99.9(us) <= " << percentile_bound_us(0.999);
+    }
+    out << std::endl;
+}
+
+bool parse_rt_profile(const std::string& spec, RTRole role, RTProfile& profile) {
+    const char* program = role == RT_SENDER ? "sender" : "receiver";
+    std::istringstream fields(spec);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        std::string key = field.substr(0, field.find('='));
+        std::string value = field.find('=') == std::string::npos ? "" : field.substr(field.find('=') + 1);
+        if (((key == "send" || key == "ack") && role != RT_SENDER) || (key == "recv" && role != RT_RECEIVER)) {
+            std::cerr << "Error: Real-time profile setting " << field << " does not apply to the " << program << "." << std::endl;
+            return false;
+        }
+        try {
+            if (key == "send") {
+                profile.send_cpu = std::stoi(value);
+            } else if (key == "ack") {
+                profile.ack_cpu = std::stoi(value);
+            } else if (key == "recv") {
+                profile.recv_cpu = std::stoi(value);
+            } else if (key == "fifo") {
+                profile.fifo_priority = std::stoi(value);
+            } else if (key == "mlock") {
+                profile.lock_memory = true;
+            } else if (key == "prefault") {
+                profile.prefault = true;
+            } else if (key == "sndbuf") {
+                profile.sndbuf = std::stoi(value);
+            } else if (key == "rcvbuf") {
+                profile.rcvbuf = std::stoi(value);
+            } else {
+                std::cerr << "Error: Unknown real-time profile setting " << field << std::endl;
+                return false;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: Invalid value in real-time profile setting " << field << std::endl;
+            return false;
+        }
+    }
+
+    if (profile.fifo_priority < 0 || profile.fifo_priority > sched_get_priority_max(SCHED_FIFO)) {
+        std::cerr << "Error: SCHED_FIFO priority must be between 1 and " << sched_get_priority_max(SCHED_FIFO) << std::endl;
+        return false;
+    }
+    int main_cpu = role == RT_SENDER ? profile.send_cpu : profile.recv_cpu;
+    if (profile.fifo_priority > 0 && main_cpu < 0) {
+        std::cerr << "Error: fifo needs the " << (role == RT_SENDER ? "send" : "recv") << " thread pinned to a CPU in the real-time profile." << std::endl;
+        return false;
+    }
+    profile.enabled = true;
+    return true;
+}
+
+bool apply_thread_profile(pthread_t thread, int cpu, int fifo_priority, const std::string& name) {
+    if (cpu < 0) {
+        return true;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    int res = pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+    if (res != 0) {
+        std::cerr << "Error: Failed to pin " << name << " thread to CPU " << cpu << ": " << strerror(res) << std::endl;
+        return false;
+    }
+
+    if (fifo_priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = fifo_priority;
+        res = pthread_setschedparam(thread, SCHED_FIFO, &param);
+        if (res != 0) {
+            std::cerr << "Error: Failed to set SCHED_FIFO priority " << fifo_priority << " for " << name << " thread: " << strerror(res) << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Touches the next PREFAULT_STACK_SIZE bytes of the calling thread's stack
+void prefault_stack() {
+    char stack[PREFAULT_STACK_SIZE];
+    volatile char* touch = stack; // Keeps the writes from being optimized away
+    for (int i = 0; i < PREFAULT_STACK_SIZE; i += sysconf(_SC_PAGESIZE)) {
+        touch[i] = 0;
+    }
+}
+
+// Grows the heap by PREFAULT_HEAP_SIZE and keeps it mapped, so later
+// allocations (e.g. the unacknowledged packet map) do not fault
+static bool prefault_heap() {
+    // Keep freed memory in the heap instead of returning it to the kernel
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    char* heap = static_cast<char*>(malloc(PREFAULT_HEAP_SIZE));
+    if (heap == NULL) {
+        std::cerr << "Error: Failed to allocate " << PREFAULT_HEAP_SIZE << " bytes to prefault the heap." << std::endl;
+        return false;
+    }
+    for (int i = 0; i < PREFAULT_HEAP_SIZE; i += sysconf(_SC_PAGESIZE)) {
+        heap[i] = 0;
+    }
+    free(heap);
+    return true;
+}
+
+int64_t rx_wakeup_lateness_ns(const struct timespec& rx_time) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (now.tv_sec - rx_time.tv_sec) * 1000000000LL + (now.tv_nsec - rx_time.tv_nsec);
+}
+
+bool apply_process_profile(const RTProfile& profile) {
+    if (profile.lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cerr << "Error: mlockall failed: " << strerror(errno) << std::endl;
+        return false;
+    }
+    if (profile.prefault) {
+        if (!prefault_heap()) {
+            return false;
+        }
+        prefault_stack();
+    }
+    return true;
+}
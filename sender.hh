@@ -3,23 +3,60 @@
 
 #include <string>
 #include <chrono>
+#include <vector>
+#include "packet-size.hh"
+#include "pcap-writer.hh"
+#include "rt-profile.hh"
+#include "timing-wheel.hh"
+#include "udp-socket.hh"
 
 // Constants
-#define PACKET_SIZE 1500
 #define HEADER_SIZE sizeof(int)  // Size of seq_number
-#define PAYLOAD_SIZE (PACKET_SIZE - HEADER_SIZE)  // Actual data size
 #define DEFAULT_BURST_SIZE 1024
 #define DEFAULT_BURST_SIZE 1024 // Example burst size in bytes
 #define DEFAULT_BURST_DURATION 40 // Example burst duration in ms
 #define DEFAULT_INTER_BURST_TIME 100 // Example inter-burst interval in ms
+#define FANOUT_TICK_US 10 // Tick length of the fan-out timing wheel in us
 
 // Packet structure for sending data
 struct Packet {
-    char data[PACKET_SIZE]; // Payload data
+    char data[MAX_PACKET_SIZE]; // Payload data, only the first packet_size bytes are sent
     //int seq_number; // Sequence number for tracking
     std::chrono::steady_clock::time_point send_time; // Timestamp for sending time
 };
 
+// Bookkeeping for a packet waiting for its ACK
+struct PacketRecord {
+    int size; // Bytes sent, credited to total_acked_bytes on ACK
+    std::chrono::steady_clock::time_point send_time;
+};
+
+// Destination of the fan-out attack, each with its own burst schedule
+struct FanoutTarget {
+    UDPSocket::SockAddress addr; // Resolved once when the targets file is loaded
+    uint64_t phase_offset_ticks; // Start of the first burst, in FANOUT_TICK_US ticks from the start of the attack
+    WheelTimer timer; // Fires for the next send or the next burst start
+    bool in_burst;
+    int burst_bytes_sent;
+    uint64_t burst_end_tick;
+    double next_send_tick; // Fractional so rounding to ticks does not skew the burst rate
+};
+
+// Attack parameters taken from the command line
+struct AttackConfig {
+    std::string target_ip;
+    int target_port;
+    UDPSocket::SockAddress target_addr;
+    std::vector<FanoutTarget> fanout_targets; // Fan-out mode when not empty
+    int packet_size;
+    int burst_size;
+    int burst_duration;
+    int inter_burst_time;
+    int duration;
+    std::string attack_type;
+    bool sleep_pacing; // Custom attack sleeps between packets instead of busy-waiting, set for a SCHED_FIFO send thread
+};
+
 // Function prototypes
 bool initialize_sender(UDPSocket& socket);
 bool send_packet(UDPSocket& socket, const Packet& packet);
@@ -0,0 +1,65 @@
+#include <cstring>
+
+#include "timing-wheel.hh"
+
+static const uint64_t SLOT_MASK = TimingWheel::WHEEL_SLOTS - 1;
+static const uint64_t MAX_DELTA = (uint64_t(1) << (TimingWheel::WHEEL_LEVELS * TimingWheel::WHEEL_SLOT_BITS)) - 1;
+
+TimingWheel::TimingWheel() : current_tick(0) {
+    memset(slots, 0, sizeof(slots));
+}
+
+// Links timer into the slot of the lowest level whose span covers the
+// time left until it expires. Timers beyond the span of the wheel are kept
+// in the top level and cascaded again when that slot comes around.
+void TimingWheel::place(WheelTimer* timer) {
+    uint64_t delta = timer->expires - current_tick;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA;
+    }
+
+    int level = 0;
+    while (level < WHEEL_LEVELS - 1 && delta >= (uint64_t(1) << ((level + 1) * WHEEL_SLOT_BITS))) {
+        level++;
+    }
+
+    uint64_t slot_tick = current_tick + delta;
+    int slot = (slot_tick >> (level * WHEEL_SLOT_BITS)) & SLOT_MASK;
+    timer->next = slots[level][slot];
+    slots[level][slot] = timer;
+}
+
+// Re-places every timer of the current slot of level into lower levels
+void TimingWheel::cascade(int level) {
+    int slot = (current_tick >> (level * WHEEL_SLOT_BITS)) & SLOT_MASK;
+    WheelTimer* timer = slots[level][slot];
+    slots[level][slot] = NULL;
+
+    while (timer != NULL) {
+        WheelTimer* next = timer->next;
+        place(timer);
+        timer = next;
+    }
+}
+
+void TimingWheel::schedule(WheelTimer* timer, uint64_t expires) {
+    timer->expires = expires > current_tick ? expires : current_tick + 1;
+    place(timer);
+}
+
+WheelTimer* TimingWheel::advance() {
+    current_tick++;
+
+    // Each time a level wraps, pull the next slot of the level above down
+    for (int level = 1; level < WHEEL_LEVELS; level++) {
+        if (((current_tick >> ((level - 1) * WHEEL_SLOT_BITS)) & SLOT_MASK) != 0) {
+            break;
+        }
+        cascade(level);
+    }
+
+    int slot = current_tick & SLOT_MASK;
+    WheelTimer* expired = slots[0][slot];
+    slots[0][slot] = NULL;
+    return expired;
+}
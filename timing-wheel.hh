@@ -0,0 +1,48 @@
+#ifndef TIMING_WHEEL_HH
+#define TIMING_WHEEL_HH
+
+#include <cstddef>
+#include <cstdint>
+
+// Timer owned by the caller and linked into a wheel slot while pending
+struct WheelTimer {
+    uint64_t expires; // Absolute tick at which the timer fires
+    int id; // Caller defined, e.g. an index into a target table
+    WheelTimer* next;
+
+    WheelTimer() : expires(0), id(0), next(NULL) {}
+};
+
+// Hierarchical timing wheel (Varghese & Lauck). Level 0 has one slot per
+// tick, each higher level covers WHEEL_SLOTS times the span of the level
+// below it. Scheduling and advancing by one tick are O(1) regardless of
+// the number of pending timers; timers are cascaded down one level at a
+// time as their expiry comes into range.
+class TimingWheel {
+public:
+    static const int WHEEL_LEVELS = 4;
+    static const int WHEEL_SLOT_BITS = 8;
+    static const int WHEEL_SLOTS = 1 << WHEEL_SLOT_BITS;
+
+private:
+    WheelTimer* slots[WHEEL_LEVELS][WHEEL_SLOTS];
+    uint64_t current_tick;
+
+    void place(WheelTimer* timer);
+    void cascade(int level);
+
+public:
+    TimingWheel();
+
+    uint64_t now() const { return current_tick; }
+
+    // Arms timer to fire at the absolute tick expires. Timers already due
+    // fire on the next tick. The timer must not already be pending.
+    void schedule(WheelTimer* timer, uint64_t expires);
+
+    // Moves the wheel forward by one tick and returns the timers that fire
+    // on it, chained through WheelTimer::next (NULL if none).
+    WheelTimer* advance();
+};
+
+#endif // TIMING_WHEEL_HH
@@ -2,7 +2,9 @@
 #include <cassert>
 #include <errno.h>
 #include <iostream>
+#include <netdb.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "udp-socket.hh"
 
@@ -50,7 +52,7 @@ int UDPSocket::bindsocket(int s_port)
 
 // Sends data to the desired address. Returns number of bytes sent if
 // successful, -1 if not.
-ssize_t UDPSocket::senddata(const char* data, ssize_t size, sockaddr_in *s_dest_addr){
+ssize_t UDPSocket::senddata(const char* data, ssize_t size, const sockaddr_in *s_dest_addr){
 	sockaddr_in dest_addr;
 	memset((char *) &dest_addr, 0, sizeof(dest_addr));
 	dest_addr.sin_family = AF_INET;
@@ -65,8 +67,8 @@ ssize_t UDPSocket::senddata(const char* data, ssize_t size, sockaddr_in *s_dest_
 	    }
 	}
 	else{
-	    dest_addr.sin_port = ((struct sockaddr_in *)s_dest_addr)->sin_port;
-	    dest_addr.sin_addr = ((struct sockaddr_in *)s_dest_addr)->sin_addr;
+	    dest_addr.sin_port = s_dest_addr->sin_port;
+	    dest_addr.sin_addr = s_dest_addr->sin_addr;
 	}
 
 	int res = sendto(udp_socket, data, size, 0, (struct sockaddr *) &dest_addr, sizeof(dest_addr));
@@ -106,6 +108,13 @@ ssize_t UDPSocket::senddata(const char* data, ssize_t size, string dest_ip, int
 // kernel time granularity, and kernel scheduling delays may cause 
 // actual timeout to exceed what is specified
 int UDPSocket::receivedata(char* buffer, int bufsize, int timeout, sockaddr_in &other_addr){
+	return receivedata(buffer, bufsize, timeout, other_addr, NULL);
+}
+
+// As above, and if rx_time is not NULL also stores the time (CLOCK_REALTIME)
+// at which the kernel received the datagram. Needs enable_rx_timestamps;
+// rx_time is zeroed if the kernel did not supply a timestamp.
+int UDPSocket::receivedata(char* buffer, int bufsize, int timeout, sockaddr_in &other_addr, struct timespec *rx_time){
 	assert(bound); // Socket not bound to an address. Please either use 'bind' or 'sendto'
 
 	unsigned int other_len;
@@ -118,7 +127,32 @@ int UDPSocket::receivedata(char* buffer, int bufsize, int timeout, sockaddr_in &
 	if( poll_val == 1){
 		if(pfds[0].revents & POLLIN){
 			other_len = sizeof(other_addr);
-			int res = recvfrom( udp_socket, buffer, bufsize, 0, (struct sockaddr*) &other_addr, &other_len );
+			int res;
+			if (rx_time == NULL) {
+				res = recvfrom( udp_socket, buffer, bufsize, 0, (struct sockaddr*) &other_addr, &other_len );
+			}
+			else {
+				struct iovec iov;
+				iov.iov_base = buffer;
+				iov.iov_len = bufsize;
+				char control[CMSG_SPACE(sizeof(struct timespec))];
+				struct msghdr msg;
+				memset(&msg, 0, sizeof(msg));
+				msg.msg_name = &other_addr;
+				msg.msg_namelen = other_len;
+				msg.msg_iov = &iov;
+				msg.msg_iovlen = 1;
+				msg.msg_control = control;
+				msg.msg_controllen = sizeof(control);
+
+				res = recvmsg( udp_socket, &msg, 0 );
+				memset(rx_time, 0, sizeof(*rx_time));
+				for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+					if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+						memcpy(rx_time, CMSG_DATA(cmsg), sizeof(*rx_time));
+					}
+				}
+			}
 			if ( res == -1 ){
 				std::cerr<<"Error while receiving datagram. Code: "<<errno<<std::endl;
 			}
@@ -136,7 +170,7 @@ int UDPSocket::receivedata(char* buffer, int bufsize, int timeout, sockaddr_in &
 	}
 	else if ( poll_val == -1 ){
 		if ( errno == 4 )
-			return receivedata(buffer, bufsize, timeout, other_addr); //to make gprof work
+			return receivedata(buffer, bufsize, timeout, other_addr, rx_time); //to make gprof work
 		std::cerr<<"There was an error while polling. Code: "<<errno<<endl;
 		return -1;
 	}
@@ -145,6 +179,52 @@ int UDPSocket::receivedata(char* buffer, int bufsize, int timeout, sockaddr_in &
 	}
 }
 
+// Sets SO_SNDBUF and SO_RCVBUF, skipping either one that is 0. The FORCE
+// variants are tried first so that privileged runs are not capped at
+// net.core.wmem_max/rmem_max. The size in effect is read back, and it is
+// an error if it is smaller than requested. Returns 0 if successful, -1 if
+// not.
+int UDPSocket::set_buffer_sizes(int sndbuf, int rcvbuf){
+	int options[2] = { SO_SNDBUF, SO_RCVBUF };
+	int force_options[2] = { SO_SNDBUFFORCE, SO_RCVBUFFORCE };
+	int sizes[2] = { sndbuf, rcvbuf };
+	const char* names[2] = { "SO_SNDBUF", "SO_RCVBUF" };
+
+	for (int i = 0; i < 2; i++) {
+		if (sizes[i] == 0)
+			continue;
+		if (setsockopt(udp_socket, SOL_SOCKET, force_options[i], &sizes[i], sizeof(sizes[i])) != 0
+			&& setsockopt(udp_socket, SOL_SOCKET, options[i], &sizes[i], sizeof(sizes[i])) != 0) {
+			std::cerr<<"Error while setting "<<names[i]<<". Code: "<<errno<<endl;
+			return -1;
+		}
+		int actual;
+		socklen_t len = sizeof(actual);
+		if (getsockopt(udp_socket, SOL_SOCKET, options[i], &actual, &len) != 0) {
+			std::cerr<<"Error while reading back "<<names[i]<<". Code: "<<errno<<endl;
+			return -1;
+		}
+		if (actual < sizes[i]) {
+			std::cerr<<names[i]<<" requested "<<sizes[i]<<" bytes but the kernel capped it at "<<actual
+				<<" bytes. Raise net.core."<<(i == 0 ? "wmem_max" : "rmem_max")<<" or run with CAP_NET_ADMIN."<<endl;
+			return -1;
+		}
+		std::cout<<names[i]<<" requested "<<sizes[i]<<" bytes, kernel uses "<<actual<<" bytes"<<endl;
+	}
+	return 0;
+}
+
+// Asks the kernel to timestamp received datagrams (SO_TIMESTAMPNS), see
+// receivedata. Returns 0 if successful, -1 if not.
+int UDPSocket::enable_rx_timestamps(){
+	int on = 1;
+	if (setsockopt(udp_socket, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) != 0) {
+		std::cerr<<"Error while enabling receive timestamps. Code: "<<errno<<endl;
+		return -1;
+	}
+	return 0;
+}
+
 void UDPSocket::decipher_socket_addr(sockaddr_in addr, std::string& ip_addr, int& port) {
 	ip_addr = inet_ntoa(addr.sin_addr);
 	port = ntohs(addr.sin_port);
@@ -155,3 +235,43 @@ string UDPSocket::decipher_socket_addr(sockaddr_in addr) {
 	UDPSocket::decipher_socket_addr(addr, ip_addr, port);
 	return ip_addr + ":" + to_string(port);
  }
+
+// Resolves host (a dotted quad or a hostname) and port into addr, so that
+// callers sending many datagrams to the same destination can look it up
+// once. Returns false if the host cannot be resolved.
+bool UDPSocket::resolve(string host, int port, sockaddr_in &addr) {
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	struct addrinfo *result;
+	int res = getaddrinfo(host.c_str(), NULL, &hints, &result);
+	if (res != 0) {
+		std::cerr<<"Could not resolve "<<host<<": "<<gai_strerror(res)<<endl;
+		return false;
+	}
+	memcpy(&addr, result->ai_addr, sizeof(addr));
+	addr.sin_port = htons(port);
+	freeaddrinfo(result);
+	return true;
+}
+
+// Finds the local address the kernel would send from to reach dest, by
+// connecting a throwaway socket (no datagram is sent). The port of local
+// is left as the kernel picked it. Returns false on failure.
+bool UDPSocket::local_address(const sockaddr_in &dest, sockaddr_in &local) {
+	int probe = socket(AF_INET, SOCK_DGRAM, 0);
+	if (probe < 0) {
+		std::cerr<<"Error while creating probe socket. Code: "<<errno<<endl;
+		return false;
+	}
+	socklen_t len = sizeof(local);
+	bool ok = connect(probe, (const struct sockaddr *) &dest, sizeof(dest)) == 0
+		&& getsockname(probe, (struct sockaddr *) &local, &len) == 0;
+	if (!ok) {
+		std::cerr<<"Error while finding the local address. Code: "<<errno<<endl;
+	}
+	close(probe);
+	return ok;
+}
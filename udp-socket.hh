@@ -6,6 +6,7 @@
 #include <netinet/in.h>
 #include <sys/poll.h>
 #include <sys/socket.h>
+#include <time.h>
 
 class UDPSocket{
 public:
@@ -25,12 +26,17 @@ public:
 
 	int bindsocket(std::string ipaddr, int port, int srcport);
 	int bindsocket(int port);
-	ssize_t senddata(const char* data, ssize_t size, SockAddress *s_dest_addr);
+	ssize_t senddata(const char* data, ssize_t size, const SockAddress *s_dest_addr);
 	ssize_t senddata(const char* data, ssize_t size, std::string dest_ip, int dest_port);
 	int receivedata(char* buffer, int bufsize, int timeout, SockAddress &other_addr);
+	int receivedata(char* buffer, int bufsize, int timeout, SockAddress &other_addr, struct timespec *rx_time);
+	int set_buffer_sizes(int sndbuf, int rcvbuf);
+	int enable_rx_timestamps();
 
 	static void decipher_socket_addr(SockAddress addr, std::string& ip_addr, int& port);
 	static std::string decipher_socket_addr(SockAddress addr);
+	static bool resolve(std::string host, int port, SockAddress& addr);
+	static bool local_address(const SockAddress& dest, SockAddress& local);
 
 	// New method to check if socket is valid
     	bool is_valid() const { return udp_socket >= 0; }